@@ -2,6 +2,7 @@
 #define SIMPLE_BUFFER_BUFFER_DEF
 #include <vector>
 #include "struct.h"
+#include "checksum.h"
 
 namespace simple_buffer
 {
@@ -40,9 +41,14 @@ private:
 	std::vector<char> vec;
 };
 
-template<typename U = vector_wrapper, bool CheckT = true, bool EndianT = true>
+// CrcT appends a CRC32C of each written frame, checked before the frame is decoded. The
+// checksum is a separate pass over the encoded bytes, not folded into the encoding, so a
+// checksummed write touches the frame twice and a read three times (extent, CRC, decode).
+template<typename U = vector_wrapper, bool CheckT = true, bool EndianT = true, bool CrcT = false>
 class buffer 
 {
+	static_assert(!CrcT || CheckT, "a checksummed buffer needs CheckT to find the frame before decoding");
+	static const size_t trailer_size = CrcT ? sizeof(uint32_t) : 0;
 public:
 	template<typename V = U, bool C = CheckT, bool E = EndianT>
 	buffer(typename std::enable_if<std::is_same<V, vector_wrapper>::value, size_t>::type mem_grow_in = 1024) 
@@ -69,13 +75,15 @@ public:
 	template <typename T>
 	buffer& read(T& t) 
 	{
-		if (CheckT && rw<T, EndianT>::size(local_buf.data(), t) > local_buf.size())
+		static_assert(!CrcT || extent_traits<T, EndianT, T>::known,
+			"a checksummed buffer finds the frame before decoding it, every rw_worker read through it needs extent()");
+		if (CheckT && check_read(t) == bad_extent)
 		{
-			// We don't have enough data to read
+			// We don't have enough data to read, or it is corrupted
 			valid = false;
 			return *this;
 		}
-		cursor += rw<T, EndianT>::read(local_buf.data(), t);
+		cursor += rw<T, EndianT>::read(local_buf.data(), t) + trailer_size;
 		return *this;
 	}
 
@@ -85,7 +93,7 @@ public:
 	{
 		if (CheckT)
 		{
-			size_t sz = rw<T, EndianT>::size(local_buf.data(), t);
+			size_t sz = rw<T, EndianT>::size(local_buf.data(), t) + trailer_size;
 			if (sz > local_buf.size() && !local_buf.resizable())
 			{
 				valid = false;
@@ -93,7 +101,10 @@ public:
 			}
 			for (; sz > local_buf.size(); inc_mem());
 		}
-		cursor += rw<T, EndianT>::write(local_buf.data(), t);
+		size_t sz = rw<T, EndianT>::write(local_buf.data(), t);
+		if (CrcT)
+			rw<uint32_t, EndianT>::write(local_buf.data() + sz, crc32c(local_buf.data(), sz));
+		cursor += sz + trailer_size;
 		return *this;
 	}
 
@@ -103,6 +114,29 @@ public:
 
 	bool resizable() { return local_buf.resizable(); }
 private:
+	// Encoded length of the next T, bad_extent if it can't be read, or unknown_extent if a
+	// user supplied rw_worker has no extent(). The walk still bounds everything before that
+	// worker; only the rest is left to the size check of t. Checksummed buffers never get
+	// here, read() refuses such types at compile time.
+	template <typename T>
+	size_t check_read(const T& t)
+	{
+		size_t avail = local_buf.size() > trailer_size ? local_buf.size() - trailer_size : 0;
+		size_t sz = rw<T, EndianT>::extent(local_buf.data(), avail);
+		if (sz == unknown_extent)
+			return rw<T, EndianT>::size(local_buf.data(), t) > avail ? bad_extent : unknown_extent;
+		if (sz == bad_extent || (CrcT && !crc_matches(sz)))
+			return bad_extent;
+		return sz;
+	}
+
+	bool crc_matches(size_t sz)
+	{
+		uint32_t crc = 0;
+		rw<uint32_t, EndianT>::read(local_buf.data() + sz, crc);
+		return crc == crc32c(local_buf.data(), sz);
+	}
+
 	void inc_mem()
 	{
 	    local_buf.resize(local_buf.size() + mem_grow);
@@ -121,6 +155,9 @@ typedef buffer<bytes_wrapper, true, true> fixed_buf;
 typedef buffer<bytes_wrapper, false, true> fixed_nocheck_buf;
 typedef buffer<bytes_wrapper, false, false> fixed_nocheck_noendian_buf;
 
+typedef buffer<vector_wrapper, true, true, true> auto_crc_buf;
+typedef buffer<bytes_wrapper, true, true, true> fixed_crc_buf;
+
 
 }
 #endif
\ No newline at end of file
@@ -0,0 +1,278 @@
+#ifndef SIMPLE_BUFFER_CHANNEL_DEF
+#define SIMPLE_BUFFER_CHANNEL_DEF
+#ifdef __linux__
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include "buffer.h"
+
+namespace simple_buffer
+{
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2 && ATOMIC_INT_LOCK_FREE == 2, "ring_channel needs address-free atomics");
+
+// Ring of fixed size slots living in a shared memory segment. Producers claim a slot,
+// encode straight into it through a fixed buffer view and publish it with a sequence
+// number; the single consumer decodes in place and hands the slot back. MultiProducerT
+// selects between a plain store (one producer) and a CAS (many producers) on the tail.
+template <bool MultiProducerT = false, bool EndianT = false>
+class ring_channel
+{
+public:
+	// Create a named segment (shm_open). Fails, good() is false, if the name already exists,
+	// so a restarted producer can't wipe a ring that live peers have mapped. Call remove()
+	// first to replace it; peers keep the old segment until they unmap it.
+	ring_channel(const char* name, uint32_t slots, uint32_t slot_size) : ring_channel()
+	{
+		int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+		if (fd >= 0) { init(fd, slots, slot_size); close(fd); }
+	}
+
+	// Attach to a named segment created by another process
+	ring_channel(const char* name) : ring_channel()
+	{
+		int fd = shm_open(name, O_RDWR, 0600);
+		if (fd >= 0) { attach(fd); close(fd); }
+	}
+
+	// Initialize (slots > 0) or attach to an already open descriptor, e.g. from memfd_create.
+	// The descriptor is not owned by the channel.
+	ring_channel(int fd, uint32_t slots = 0, uint32_t slot_size = 0) : ring_channel()
+	{
+		if (slots > 0) init(fd, slots, slot_size);
+		else attach(fd);
+	}
+
+	ring_channel(const ring_channel&) = delete;
+	ring_channel& operator=(const ring_channel&) = delete;
+
+	~ring_channel() { if (base) munmap(base, mapped); }
+
+	static bool remove(const char* name) { return shm_unlink(name) == 0; }
+
+	bool good() { return base != nullptr; }
+
+	uint32_t slot_size() { return hdr->slot_size; }
+
+	// Encode t into the next free slot. Fails if the ring is full or t doesn't fit a slot.
+	template <typename T>
+	bool send(const T& t)
+	{
+		if (rw<T, EndianT>::size(payload(0), t) > hdr->slot_size)
+			return false;
+		uint64_t pos = hdr->tail.load(std::memory_order_relaxed);
+		slot_header* s;
+		for (;;)
+		{
+			s = slot(pos);
+			int64_t diff = (int64_t)(s->seq.load(std::memory_order_acquire) - pos);
+			if (diff < 0)
+				return false;
+			if (diff > 0)
+				pos = hdr->tail.load(std::memory_order_relaxed);
+			else if (claim(pos))
+				break;
+		}
+		// Already known to fit, so the object isn't sized a second time
+		writer_type view(payload(pos), hdr->slot_size);
+		view.write(t);
+		s->length = (uint32_t)view.size();
+		s->seq.store(pos + 1, std::memory_order_release);
+		hdr->signal.fetch_add(1);
+		if (hdr->waiters.load() > 0)
+			futex(&hdr->signal, FUTEX_WAKE, INT32_MAX, nullptr);
+		return true;
+	}
+
+	// Decode the oldest message into t. Only one consumer may call this at a time. Returns
+	// false if the ring is empty, or if the oldest message could not be decoded, in which
+	// case it is dropped.
+	template <typename T>
+	bool receive(T& t) { return receive_status(t) == status_ok; }
+
+	// As receive, but spin for a while and then sleep on a futex until a message arrives.
+	// A negative timeout waits forever. Returns false on timeout or on a message that could
+	// not be decoded.
+	template <typename T>
+	bool receive_wait(T& t, long timeout_us = -1, int spin = 1024)
+	{
+		int st = status_empty;
+		for (int i = 0; i < spin && st == status_empty; i++)
+			st = receive_status(t);
+		if (st != status_empty)
+			return st == status_ok;
+		timespec deadline;
+		if (timeout_us >= 0)
+		{
+			clock_gettime(CLOCK_MONOTONIC, &deadline);
+			add_us(deadline, timeout_us);
+		}
+		for (;;)
+		{
+			hdr->waiters.fetch_add(1);
+			uint32_t sig = hdr->signal.load();
+			st = receive_status(t);
+			bool expired = false;
+			if (st == status_empty)
+			{
+				timespec left;
+				if (timeout_us < 0)
+					futex(&hdr->signal, FUTEX_WAIT, sig, nullptr);
+				else if (remaining(deadline, left))
+					futex(&hdr->signal, FUTEX_WAIT, sig, &left);
+				else
+					expired = true;
+			}
+			hdr->waiters.fetch_sub(1);
+			if (st != status_empty)
+				return st == status_ok;
+			if (expired)
+				return false;
+		}
+	}
+
+private:
+	typedef buffer<bytes_wrapper, true, EndianT> view_type;
+	typedef buffer<bytes_wrapper, false, EndianT> writer_type;
+	static const uint32_t magic_value = 0x53425243;	// "SBRC"
+	static const size_t cache_line = 64;
+
+	struct ring_header
+	{
+		std::atomic<uint32_t> magic;
+		uint32_t slots, slot_size, stride;
+		alignas(cache_line) std::atomic<uint64_t> tail;
+		alignas(cache_line) std::atomic<uint64_t> head;
+		alignas(cache_line) std::atomic<uint32_t> signal;
+		std::atomic<uint32_t> waiters;
+	};
+
+	struct slot_header
+	{
+		std::atomic<uint64_t> seq;
+		uint32_t length;
+	};
+
+	enum { status_ok, status_empty, status_corrupt };
+
+	ring_channel() : base(nullptr), hdr(nullptr), mapped(0) {}
+
+	template <typename T>
+	int receive_status(T& t)
+	{
+		uint64_t pos = hdr->head.load(std::memory_order_relaxed);
+		slot_header* s = slot(pos);
+		if (s->seq.load(std::memory_order_acquire) != pos + 1)
+			return status_empty;
+		view_type view(payload(pos), s->length);
+		bool ok = view.read(t).good();
+		s->seq.store(pos + hdr->slots, std::memory_order_release);
+		hdr->head.store(pos + 1, std::memory_order_relaxed);
+		return ok ? status_ok : status_corrupt;
+	}
+
+	static void add_us(timespec& ts, long us)
+	{
+		ts.tv_sec += us / 1000000;
+		ts.tv_nsec += (us % 1000000) * 1000;
+		if (ts.tv_nsec >= 1000000000) { ts.tv_sec++; ts.tv_nsec -= 1000000000; }
+	}
+
+	// Time left until deadline, false once it has passed
+	static bool remaining(const timespec& deadline, timespec& left)
+	{
+		timespec now;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		left.tv_sec = deadline.tv_sec - now.tv_sec;
+		left.tv_nsec = deadline.tv_nsec - now.tv_nsec;
+		if (left.tv_nsec < 0) { left.tv_sec--; left.tv_nsec += 1000000000; }
+		return left.tv_sec > 0 || (left.tv_sec == 0 && left.tv_nsec > 0);
+	}
+
+	static size_t align_up(size_t n) { return (n + cache_line - 1) / cache_line * cache_line; }
+
+	void init(int fd, uint32_t slots, uint32_t slot_size)
+	{
+		size_t stride = align_up(sizeof(slot_header) + slot_size);
+		size_t len = align_up(sizeof(ring_header)) + stride * slots;
+		if (ftruncate(fd, len) != 0 || !map(fd, len))
+			return;
+		hdr->magic.store(0, std::memory_order_relaxed);
+		hdr->slots = slots;
+		hdr->slot_size = slot_size;
+		hdr->stride = (uint32_t)stride;
+		hdr->tail.store(0);
+		hdr->head.store(0);
+		hdr->signal.store(0);
+		hdr->waiters.store(0);
+		for (uint32_t i = 0; i < slots; i++)
+		{
+			slot(i)->seq.store(i);
+			slot(i)->length = 0;
+		}
+		// Publishes the header and slots above to peers that see the magic
+		hdr->magic.store(magic_value, std::memory_order_release);
+	}
+
+	void attach(int fd)
+	{
+		struct stat st;
+		if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(ring_header) || !map(fd, st.st_size))
+			return;
+		if (hdr->magic.load(std::memory_order_acquire) != magic_value || align_up(sizeof(ring_header)) + (size_t)hdr->stride * hdr->slots > mapped)
+		{
+			munmap(base, mapped);
+			base = nullptr;
+		}
+	}
+
+	bool map(int fd, size_t len)
+	{
+		void* p = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		if (p == MAP_FAILED)
+			return false;
+		base = static_cast<char*>(p);
+		hdr = reinterpret_cast<ring_header*>(base);
+		mapped = len;
+		return true;
+	}
+
+	bool claim(uint64_t& pos)
+	{
+		if (!MultiProducerT)
+		{
+			hdr->tail.store(pos + 1, std::memory_order_relaxed);
+			return true;
+		}
+		return hdr->tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed);
+	}
+
+	slot_header* slot(uint64_t pos)
+	{
+		return reinterpret_cast<slot_header*>(base + align_up(sizeof(ring_header)) + (pos % hdr->slots) * hdr->stride);
+	}
+
+	char* payload(uint64_t pos) { return reinterpret_cast<char*>(slot(pos)) + sizeof(slot_header); }
+
+	static long futex(std::atomic<uint32_t>* addr, int op, uint32_t val, const timespec* ts)
+	{
+		return syscall(SYS_futex, reinterpret_cast<uint32_t*>(addr), op, val, ts, nullptr, 0);
+	}
+
+	char* base;
+	ring_header* hdr;
+	size_t mapped;
+};
+
+typedef ring_channel<false> spsc_channel;
+typedef ring_channel<true> mpsc_channel;
+
+}
+#endif // __linux__
+#endif // end of SIMPLE_BUFFER_CHANNEL_DEF
\ No newline at end of file
@@ -0,0 +1,70 @@
+#ifndef SIMPLE_BUFFER_CHECKSUM_DEF
+#define SIMPLE_BUFFER_CHECKSUM_DEF
+#include <cstdint>
+#include <cstring>
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <nmmintrin.h>
+#define SIMPLE_BUFFER_CRC32C_HW
+#endif
+
+namespace simple_buffer
+{
+
+// CRC32C (Castagnoli), with the SSE4.2 crc32 instruction when the CPU has it and a
+// table otherwise
+struct crc32c_table
+{
+	crc32c_table()
+	{
+		for (uint32_t i = 0; i < 256; i++)
+		{
+			uint32_t c = i;
+			for (int k = 0; k < 8; k++)
+				c = (c & 1) ? (c >> 1) ^ 0x82f63b78 : c >> 1;
+			t[i] = c;
+		}
+	}
+	uint32_t t[256];
+};
+
+inline uint32_t crc32c_sw(uint32_t crc, const char* data, size_t len)
+{
+	static const crc32c_table table;
+	for (size_t i = 0; i < len; i++)
+		crc = table.t[(crc ^ (uint8_t)data[i]) & 0xff] ^ (crc >> 8);
+	return crc;
+}
+
+#ifdef SIMPLE_BUFFER_CRC32C_HW
+__attribute__((target("sse4.2")))
+inline uint32_t crc32c_hw(uint32_t crc, const char* data, size_t len)
+{
+	uint64_t c = crc;
+	for (; len >= sizeof(uint64_t); len -= sizeof(uint64_t), data += sizeof(uint64_t))
+	{
+		uint64_t v;
+		std::memcpy(&v, data, sizeof(v));
+		c = _mm_crc32_u64(c, v);
+	}
+	crc = (uint32_t)c;
+	for (; len > 0; len--)
+		crc = _mm_crc32_u8(crc, (uint8_t)*data++);
+	return crc;
+}
+#endif
+
+inline uint32_t crc32c(const char* data, size_t len, uint32_t crc = 0)
+{
+	crc = ~crc;
+#ifdef SIMPLE_BUFFER_CRC32C_HW
+	static const bool hw = __builtin_cpu_supports("sse4.2");
+	crc = hw ? crc32c_hw(crc, data, len) : crc32c_sw(crc, data, len);
+#else
+	crc = crc32c_sw(crc, data, len);
+#endif
+	return ~crc;
+}
+// End CRC32C
+
+}
+#endif // end of SIMPLE_BUFFER_CHECKSUM_DEF
\ No newline at end of file
@@ -2,6 +2,13 @@
 #define SIMPLE_BUFFER_CONDITIONS_DEF
 
 #include <type_traits>
+#include <cstdint>
+#include <tuple>
+#include <vector>
+#include <deque>
+#include <forward_list>
+#include <map>
+#include <set>
 
 #ifdef __MINGW32__
 #include "Winsock2.h"
@@ -17,12 +24,26 @@ namespace simple_buffer
 typedef std::true_type yes;
 typedef std::false_type no;
 
+// Extent of an encoding that would run past the available bytes
+const size_t bad_extent = ~size_t(0);
+// Extent that can't be known, a user supplied rw_worker without extent() is involved
+const size_t unknown_extent = bad_extent - 1;
+
+inline bool extent_failed(size_t sz) { return sz >= unknown_extent; }
+
 // Alignment size for struct field
 template <typename T>
 struct field_aligned_size
 {
 	static const size_t value = sizeof(T) + (sizeof(void*) - sizeof(T) % sizeof(void*)) % sizeof(void*);
 };
+
+// Alignment of a FIELD member, pointer sized unless the struct uses the packed layout
+template <typename P, typename T>
+struct field_alignment { static const size_t value = sizeof(void*); };
+
+template <typename T>
+struct field_alignment<std::true_type, T> { static const size_t value = alignof(T); };
 // end for alignment size
 
 // Condition for endian ops
@@ -40,7 +61,45 @@ private:
 public:
 	static const bool value = std::is_same<decltype(has_type<T>(0)), yes>::value;
 };
-// end for our serializable struct
+
+// Serializable struct declared with PACKED_FIELD_START
+template <typename T>
+struct is_packed_struct
+{
+private:
+	template <typename U> static typename U::_packed_layout_ test(int);
+	template <typename U> static no test(...);
+public:
+	static const bool value = decltype(test<T>(0))::value;
+};
+// end for packed struct
+
+// Type of a BITFIELD member, N bits of an integral, bool or enum type T
+template <typename T, size_t N>
+struct bit_field
+{
+	typedef typename std::conditional<std::is_enum<T>::value, std::underlying_type<T>, std::common_type<T>>::type::type int_type;
+	static_assert(std::is_integral<int_type>::value && N > 0 && N <= sizeof(T) * 8, "invalid BITFIELD");
+	typedef T value_type;
+	static const size_t bits = N;
+
+	static uint64_t to_bits(T v) { return (uint64_t)(int_type)v & mask(); }
+	static T from_bits(uint64_t b)
+	{
+		if (std::is_signed<int_type>::value && N < 64 && (b >> (N - 1)) & 1)
+			b |= ~mask();
+		return (T)(int_type)b;
+	}
+private:
+	static uint64_t mask() { return N < 64 ? (uint64_t(1) << (N % 64)) - 1 : ~uint64_t(0); }
+};
+
+template <typename T>
+struct is_bit_field : no {};
+
+template <typename T, size_t N>
+struct is_bit_field<bit_field<T, N>> : yes {};
+// end for bit field
 
 // For stl iterable and modifable container 
 template <typename T>
@@ -76,6 +135,49 @@ struct is_modifiable_container
 };
 // End for stl iterable and modifiable container
 
+// Containers decoded in bulk (resized once, elements read in place)
+template <typename T>
+struct is_resizable_sequence : no {};
+
+template <typename T, typename A>
+struct is_resizable_sequence<std::vector<T, A>> : yes {};
+
+template <typename A>
+struct is_resizable_sequence<std::vector<bool, A>> : no {};
+
+template <typename T, typename A>
+struct is_resizable_sequence<std::deque<T, A>> : yes {};
+
+// Ordered associative containers, written in key order
+template <typename T>
+struct is_ordered_associative : no {};
+
+template <typename K, typename V, typename C, typename A>
+struct is_ordered_associative<std::map<K, V, C, A>> : yes {};
+
+template <typename K, typename V, typename C, typename A>
+struct is_ordered_associative<std::multimap<K, V, C, A>> : yes {};
+
+template <typename K, typename C, typename A>
+struct is_ordered_associative<std::set<K, C, A>> : yes {};
+
+template <typename K, typename C, typename A>
+struct is_ordered_associative<std::multiset<K, C, A>> : yes {};
+
+// Containers with a dedicated rw_worker, kept out of the generic container path
+template <typename T>
+struct has_dedicated_rw
+{
+	static const bool value = is_resizable_sequence<T>::value || is_ordered_associative<T>::value;
+};
+
+template <typename A>
+struct has_dedicated_rw<std::vector<bool, A>> : yes {};
+
+template <typename T, typename A>
+struct has_dedicated_rw<std::forward_list<T, A>> : yes {};
+// End for dedicated containers
+
 
 // Network byte order operations for arithmetic types
 template <size_t N>
@@ -132,5 +234,13 @@ struct remove_tuple_head<std::tuple<T, Ts...>>
 	typedef typename std::conditional<(std::tuple_size<std::tuple<Ts...>>::value > 0), std::tuple<Ts...>, std::tuple<>>::type type; 
 };
 // end remove head for tuple
+
+// Field types of a tuple of field marks
+template <typename T>
+struct mark_types {};
+
+template <typename ...Ms>
+struct mark_types<std::tuple<Ms...>> { typedef std::tuple<typename Ms::type...> type; };
+// end field types of marks
 }
 #endif // end of SIMPLE_BUFFER_CONDITIONS_DEF
\ No newline at end of file
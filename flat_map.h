@@ -0,0 +1,148 @@
+#ifndef SIMPLE_BUFFER_FLAT_MAP_DEF
+#define SIMPLE_BUFFER_FLAT_MAP_DEF
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include "read_write.h"
+
+namespace simple_buffer
+{
+
+// Map kept as a vector of pairs sorted by key. Same wire format as std::map, but decoded
+// as one contiguous block instead of one tree node per element.
+template <typename K, typename V, typename C = std::less<K>>
+class flat_map
+{
+public:
+	typedef K key_type;
+	typedef V mapped_type;
+	typedef std::pair<K, V> value_type;
+	typedef C key_compare;
+	typedef std::vector<value_type> container_type;
+	typedef typename container_type::iterator iterator;
+	typedef typename container_type::const_iterator const_iterator;
+
+	flat_map() {}
+	flat_map(std::initializer_list<value_type> il) : vec(il) { restore_order(); }
+
+	iterator begin() { return vec.begin(); }
+	iterator end() { return vec.end(); }
+	const_iterator begin() const { return vec.begin(); }
+	const_iterator end() const { return vec.end(); }
+	size_t size() const { return vec.size(); }
+	bool empty() const { return vec.empty(); }
+	void clear() { vec.clear(); }
+	void reserve(size_t n) { vec.reserve(n); }
+
+	iterator lower_bound(const K& k)
+	{ return std::lower_bound(vec.begin(), vec.end(), k, key_less(comp)); }
+	const_iterator lower_bound(const K& k) const
+	{ return std::lower_bound(vec.begin(), vec.end(), k, key_less(comp)); }
+
+	iterator find(const K& k)
+	{
+		iterator it = lower_bound(k);
+		return it != vec.end() && !comp(k, it->first) ? it : vec.end();
+	}
+	const_iterator find(const K& k) const
+	{
+		const_iterator it = lower_bound(k);
+		return it != vec.end() && !comp(k, it->first) ? it : vec.end();
+	}
+
+	size_t count(const K& k) const { return find(k) != vec.end() ? 1 : 0; }
+
+	std::pair<iterator, bool> insert(const value_type& v)
+	{
+		iterator it = lower_bound(v.first);
+		if (it != vec.end() && !comp(v.first, it->first))
+			return std::make_pair(it, false);
+		return std::make_pair(vec.insert(it, v), true);
+	}
+
+	V& operator[](const K& k) { return insert(value_type(k, V())).first->second; }
+
+	iterator erase(iterator it) { return vec.erase(it); }
+
+	// Take the underlying vector out, and put one back. A replaced vector is sorted and
+	// deduplicated (first occurrence wins) only if it isn't already strictly ordered.
+	container_type extract() { container_type v(std::move(vec)); vec.clear(); return v; }
+	void replace(container_type&& v) { vec = std::move(v); restore_order(); }
+
+private:
+	struct key_less
+	{
+		key_less(const C& c) : comp(c) {}
+		bool operator()(const value_type& a, const value_type& b) const { return comp(a.first, b.first); }
+		bool operator()(const value_type& a, const K& b) const { return comp(a.first, b); }
+		const C& comp;
+	};
+
+	void restore_order()
+	{
+		key_less less(comp);
+		auto unordered = std::adjacent_find(vec.begin(), vec.end(),
+			[&less](const value_type& a, const value_type& b) { return !less(a, b); });
+		if (unordered == vec.end())
+			return;
+		std::stable_sort(vec.begin(), vec.end(), less);
+		vec.erase(std::unique(vec.begin(), vec.end(),
+			[&less](const value_type& a, const value_type& b) { return !less(a, b); }), vec.end());
+	}
+
+	container_type vec;
+	C comp;
+};
+
+template <typename K, typename V, typename C>
+struct has_dedicated_rw<flat_map<K, V, C>> : yes {};
+
+template <typename K, typename V, typename C, bool E>
+struct extent_traits<flat_map<K, V, C>, E, flat_map<K, V, C>>
+{
+	typedef std::pair<K, V> elem_type;
+	static const size_t min_size = sizeof(uint32_t);
+	static const bool known = extent_traits<elem_type, E, elem_type>::known;
+};
+
+// Decoded straight into the underlying vector, then checked for order
+template <typename K, typename V, typename C, bool E>
+struct rw_worker<flat_map<K, V, C>, E, flat_map<K, V, C>>
+{
+	typedef flat_map<K, V, C> map_type;
+	typedef typename map_type::container_type container_type;
+	typedef typename map_type::value_type value_type;
+
+	static size_t read(const char* data, map_type& t)
+	{
+		container_type vec = t.extract();
+		size_t sz = rw_worker<container_type, E, container_type>::read(data, vec);
+		t.replace(std::move(vec));
+		return sz;
+	}
+
+	static size_t write(char* data, const map_type& t)
+	{
+		const char* old = data;
+		data += rw_worker<uint32_t, E, uint32_t>::write(data, t.size());
+		for (auto& i : t)
+			data += rw_worker<value_type, E, value_type>::write(data, i);
+		return data - old;
+	}
+
+	static size_t size(const char* data, const map_type& t)
+	{
+		const char* old = data;
+		data += sizeof(uint32_t);
+		for (auto& i : t)
+			data += rw_worker<value_type, E, value_type>::size(data, i);
+		return data - old;
+	}
+
+	static size_t extent(const char* data, size_t avail)
+	{ return counted_extent<value_type, E>(data, avail); }
+};
+// End flat_map
+
+}
+#endif // end of SIMPLE_BUFFER_FLAT_MAP_DEF
\ No newline at end of file
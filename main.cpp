@@ -9,21 +9,30 @@
 #include <unordered_set>
 #include "struct.h"
 #include "buffer.h"
+#include "channel.h"
+#include "flat_map.h"
 
 
 using namespace simple_buffer;
 
 /*
-Support STL containers, vector, map, set, list, tuple, pair, array, deque
-std::string
+Support STL containers, vector, map, set, list, forward_list, tuple, pair, array, deque
+std::string, std::unique_ptr, and with C++17 std::optional, std::variant, std::string_view
+simple_buffer::flat_map (flat_map.h), a sorted vector map with the same wire format as std::map
 fundamental types and raw arrays (without limit to the extent and rank)
 and our serializable structs equipped with FIELD macros (there is no difference between an integer 
 type and our serializable struct type)
 
-Currently pointers are not supported. It is possible, but can be much more compilicated, 
+Currently raw pointers are not supported. It is possible, but can be much more compilicated, 
 as pointers can form loops and they can point to the same object
 
-Can support user defined types if the corresponding read/write code is provided.
+Can support user defined types if the corresponding read/write code is provided. An rw_worker
+that also provides extent(data, avail) gets its input bounds checked by checked buffers; one
+without it falls back to a size check of the object being read into, and can't be read
+through checksummed buffers (auto_crc_buf, fixed_crc_buf).
+
+Start with PACKED_FIELD_START instead of FIELD_START for natural member alignment and 
+BITFIELD(name, bits, type) members, which are bit-packed in memory and on the wire.
 
 Normal members can be added after the FIELD_END macro, but they will not be serialized/deserialized. 
  
@@ -99,6 +108,37 @@ struct my_packet
 	}
 };
 
+// A later version of part of my_packet: fields reordered, one added, the rest dropped
+struct my_packet_v2
+{
+	FIELD_START();
+	FIELD(c, std::string);
+	FIELD(extra, int);
+	FIELD(b, uint32_t);
+	FIELD(h, double);
+	FIELD_END();
+};
+
+enum class priority : uint8_t { low, normal, high, urgent };
+
+// Packed layout, the three bit fields share one byte in memory and on the wire
+struct packet_header
+{
+	PACKED_FIELD_START();
+	BITFIELD(urgent, 1, bool);
+	BITFIELD(prio, 2, priority);
+	BITFIELD(offset, 5, int8_t);
+	FIELD(length, uint16_t);
+	FIELD_END();
+};
+
+// No serialized members, each one encodes to zero bytes
+struct empty_marker
+{
+	FIELD_START();
+	FIELD_END();
+};
+
 int main()
 {
 	auto_buf ab;
@@ -119,4 +159,73 @@ int main()
 	ab.read(vvss);
 	for (auto& s : vvss) std::cout << s << " ";
 	std::cout << std::endl;
+
+	//Elements that encode to nothing, read back from a fixed buffer holding just the written bytes
+	std::vector<empty_marker> markers(3);
+	ab.reset();
+	std::string marker_bytes = ab.write(markers).str();
+	fixed_buf mb(&marker_bytes[0], marker_bytes.size());
+	decltype(markers) markers2;
+	mb.read(markers2);
+	std::cout << "empty elements, bytes = " << marker_bytes.size() << ", good = " << mb.good() << ", read = " << markers2.size() << std::endl;
+
+	std::cout <<"------ " << std::endl;
+	//flat_map shares the wire format of std::map, so it decodes the bytes of my_packet::f
+	ab.reset();
+	ab.write(mp1.f);
+	flat_map<std::string, std::vector<int>> fm;
+	ab.read(fm);
+	std::cout << "flat_map from map bytes, good = " << ab.good() << ", size = " << fm.size()
+			  << ", Sydney[3] = " << fm.find("Sydney")->second[3] << ", first = " << fm.begin()->first << std::endl;
+
+	std::cout <<"------ " << std::endl;
+	//Packed struct with bit fields, a signed one sign extends on read
+	packet_header ph{};
+	ph.urgent = true; ph.prio = priority::high; ph.offset = -3; ph.length = 1500;
+	ab.reset();
+	size_t ph_wire = ab.write(ph).size();
+	packet_header ph2{};
+	ab.read(ph2);
+	std::cout << "packed header, sizeof = " << sizeof(packet_header) << ", wire = " << ph_wire
+			  << ", urgent = " << ph2.urgent << ", prio = " << int(ph2.prio) << ", offset = " << int(ph2.offset)
+			  << ", length = " << ph2.length << std::endl;
+
+	std::cout <<"------ " << std::endl;
+	//Versioned envelope, fast path when the schema fingerprints match, tagged path otherwise
+	ab.write(make_versioned(mp1));
+	my_packet mp3;
+	auto vmp = make_versioned(mp3);
+	ab.read(vmp);
+	std::cout << "fingerprint = " << std::hex << schema_fingerprint<my_packet>::value << std::dec
+			  << ", fast path = " << (vmp.path == schema_path::fast) << ", c = " << mp3.c << std::endl;
+
+	//Another schema can't decode a fast payload and the read fails
+	my_packet_v2 v2{};
+	auto vv2 = make_versioned(v2);
+	ab.reset();
+	ab.write(make_versioned(mp1));
+	ab.read(vv2);
+	std::cout << "fast payload into v2, good = " << ab.good() << std::endl;
+
+	//Tagged mode, which writers use during rollouts, matches fields by name and type
+	ab.reset();
+	ab.write(make_versioned(mp1, true));
+	ab.read(vv2);
+	std::cout << "tagged payload into v2, good = " << ab.good() << ", tagged path = " << (vv2.path == schema_path::tagged)
+			  << ", c = " << v2.c << ", b = " << std::hex << v2.b << std::dec << ", h = " << v2.h << ", extra = " << v2.extra << std::endl;
+
+#ifdef __linux__
+	std::cout <<"------ " << std::endl;
+	//Shared memory ring between processes, here both ends live in this one
+	spsc_channel producer("/simple_buffer_demo", 4, 1024);
+	spsc_channel consumer("/simple_buffer_demo");
+	spsc_channel::remove("/simple_buffer_demo");
+	if (producer.good() && consumer.good())
+	{
+		producer.send(mp1);
+		my_packet mp4;
+		bool ok = consumer.receive_wait(mp4, 1000);
+		std::cout << "ring channel, received = " << ok << ", c = " << mp4.c << std::endl;
+	}
+#endif
 }
\ No newline at end of file
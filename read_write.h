@@ -2,6 +2,14 @@
 #define SIMPLE_BUFFER_READ_WRITE_DEF
 #include <type_traits>
 #include <cstring>
+#include <string>
+#include <algorithm>
+#include <memory>
+#if __cplusplus >= 201703L
+#include <optional>
+#include <variant>
+#include <string_view>
+#endif
 #include "definitions.h"
 namespace simple_buffer
 {
@@ -10,9 +18,197 @@ namespace simple_buffer
 template <typename T, bool E, typename TagT = void>
 struct rw_worker{};
 
+// Workers written before extent() existed only provide read, write and size
+template <typename W>
+struct has_extent
+{
+private:
+	template <typename U> static auto test(int) -> decltype(U::extent((const char*)0, size_t(0)), yes());
+	template <typename U> static no test(...);
+public:
+	static const bool value = std::is_same<decltype(test<W>(0)), yes>::value;
+};
+
+template <typename W>
+size_t call_extent(const char* data, size_t avail, yes) { return W::extent(data, avail); }
+
+template <typename W>
+size_t call_extent(const char* data, size_t avail, no) { return unknown_extent; }
+
+// Extent of a T through its worker, unknown_extent if the worker can't tell
+template <typename T, bool E>
+size_t worker_extent(const char* data, size_t avail)
+{
+	typedef rw_worker<T, E, T> worker;
+	return call_extent<worker>(data, avail, typename std::conditional<has_extent<worker>::value, yes, no>::type());
+}
+
+// Compile-time facts about the encoding of a T: the fewest bytes any value takes, 0 when
+// that isn't known, and whether its worker and every worker below it provide extent()
+template <typename T, bool E, typename TagT = void>
+struct extent_traits
+{
+	static const size_t min_size = 0;
+	static const bool known = has_extent<rw_worker<T, E, T>>::value;
+};
+
+// Fold over the types of a tuple, which are encoded back to back
+template <typename T, bool E>
+struct extent_fold
+{
+	static const size_t min_size = 0;
+	static const bool known = true;
+};
+
+template <typename T, typename ...Ts, bool E>
+struct extent_fold<std::tuple<T, Ts...>, E>
+{
+	typedef typename std::remove_cv<T>::type head_type;
+	static const size_t min_size = extent_traits<head_type, E, head_type>::min_size + extent_fold<std::tuple<Ts...>, E>::min_size;
+	static const bool known = extent_traits<head_type, E, head_type>::known && extent_fold<std::tuple<Ts...>, E>::known;
+};
+
+template <typename T, bool E>
+struct extent_traits<T, E, typename std::enable_if<std::is_arithmetic<T>::value, T>::type>
+{
+	static const size_t min_size = sizeof(T);
+	static const bool known = true;
+};
+
+template <bool E>
+struct extent_traits<std::string, E, std::string>
+{
+	static const size_t min_size = sizeof(uint32_t);
+	static const bool known = true;
+};
+
+template <typename T, bool E>
+struct extent_traits<T, E, typename std::enable_if<is_modifiable_container<T>::value && (!has_dedicated_rw<T>::value
+				|| is_resizable_sequence<T>::value || is_ordered_associative<T>::value), T>::type>
+{
+	typedef typename T::value_type elem_type;
+	static const size_t min_size = sizeof(uint32_t);
+	static const bool known = extent_traits<elem_type, E, elem_type>::known;
+};
+
+template <typename A, bool E>
+struct extent_traits<std::vector<bool, A>, E, std::vector<bool, A>>
+{
+	static const size_t min_size = sizeof(uint32_t);
+	static const bool known = true;
+};
+
+template <typename T, typename A, bool E>
+struct extent_traits<std::forward_list<T, A>, E, std::forward_list<T, A>>
+{
+	static const size_t min_size = sizeof(uint32_t);
+	static const bool known = extent_traits<T, E, T>::known;
+};
+
+template <typename T, typename D, bool E>
+struct extent_traits<std::unique_ptr<T, D>, E, std::unique_ptr<T, D>>
+{
+	static const size_t min_size = 1;
+	static const bool known = extent_traits<T, E, T>::known;
+};
+
+#if __cplusplus >= 201703L
+template <typename T, bool E>
+struct extent_traits<std::optional<T>, E, std::optional<T>>
+{
+	static const size_t min_size = 1;
+	static const bool known = extent_traits<T, E, T>::known;
+};
+
+template <typename ...Ts, bool E>
+struct extent_traits<std::variant<Ts...>, E, std::variant<Ts...>>
+{
+	static const size_t min_size = 1;
+	static const bool known = extent_fold<std::tuple<Ts...>, E>::known;
+};
+
+template <bool E>
+struct extent_traits<std::string_view, E, std::string_view>
+{
+	static const size_t min_size = sizeof(uint32_t);
+	static const bool known = true;
+};
+#endif
+
+template <typename T, bool E>
+struct extent_traits<T, E, typename std::enable_if<std::is_array<T>::value, T>::type>
+{
+	typedef typename std::remove_cv<typename std::remove_extent<T>::type>::type elem_type;
+	static const size_t min_size = std::extent<T, 0>::value * extent_traits<elem_type, E, elem_type>::min_size;
+	static const bool known = extent_traits<elem_type, E, elem_type>::known;
+};
+
+template <typename T, size_t N, bool E>
+struct extent_traits<std::array<T, N>, E, std::array<T, N>>
+{
+	static const size_t min_size = N * extent_traits<T, E, T>::min_size;
+	static const bool known = extent_traits<T, E, T>::known;
+};
+
+template <typename U, typename V, bool E>
+struct extent_traits<std::pair<U, V>, E, std::pair<U, V>> : extent_fold<std::tuple<U, V>, E> {};
+
+template <typename T, bool E>
+struct extent_traits<T, E, typename std::enable_if<!std::is_void<typename remove_tuple_head<T>::type>::value, T>::type>
+	: extent_fold<T, E> {};
+
+template <typename T, bool E>
+struct extent_traits<T, E, typename std::enable_if<is_serializable_struct<T>::value, T>::type>
+	: extent_fold<typename T::type_list, E> {};
+
+// Consecutive bit fields share bytes, so one on its own has no whole byte minimum
+template <typename T, size_t N, bool E>
+struct extent_traits<bit_field<T, N>, E, bit_field<T, N>>
+{
+	static const size_t min_size = 0;
+	static const bool known = true;
+};
+// End extent traits
+
+// Encoded bytes taken by count elements of type T, or bad_extent if they overrun avail.
+// Failures, bad_extent or unknown_extent, are passed up unchanged by every extent().
+template <typename T, bool E>
+size_t elems_extent(const char* data, size_t avail, size_t count)
+{
+	if (std::is_arithmetic<T>::value)
+		return count <= avail / sizeof(T) ? count * sizeof(T) : bad_extent;
+	size_t used = 0;
+	for (size_t i = 0; i < count; i++)
+	{
+		size_t sz = worker_extent<T, E>(data + used, avail - used);
+		if (extent_failed(sz))
+			return sz;
+		used += sz;
+	}
+	return used;
+}
+
+// Same for a uint32 element count followed by the elements. When T has a minimum encoded
+// size it bounds a corrupted count before anything is walked or allocated; elements that
+// can encode to nothing, such as empty structs, are only walked.
+template <typename T, bool E>
+size_t counted_extent(const char* data, size_t avail)
+{
+	const size_t min_size = extent_traits<T, E, T>::min_size;
+	uint32_t count = 0;
+	if (avail < sizeof(uint32_t))
+		return bad_extent;
+	rw_worker<uint32_t, E, uint32_t>::read(data, count);
+	avail -= sizeof(uint32_t);
+	if (min_size > 0 && count > avail / min_size)
+		return bad_extent;
+	size_t sz = elems_extent<T, E>(data + sizeof(uint32_t), avail, count);
+	return extent_failed(sz) ? sz : sizeof(uint32_t) + sz;
+}
+
 // For serializable struct type
 template <typename T, bool E>
-struct rw_worker<T, E, typename std::enable_if<is_serializable_struct<T>::value, T>::type>
+struct rw_worker<T, E, typename std::enable_if<is_serializable_struct<T>::value && !is_packed_struct<T>::value, T>::type>
 {
 public:
 	typedef typename std::conditional<(std::tuple_size<typename T::type_list>::value > 0), yes, no>::type bool_type;
@@ -31,6 +227,11 @@ public:
 		return size<typename T::type_list>(data, reinterpret_cast<const char*>(&t), bool_type());
 	}
 
+	static size_t extent(const char* data, size_t avail)
+	{
+		return extent<typename T::type_list>(data, avail, bool_type());
+	}
+
 private:
 	template <typename U>
 	static size_t read(const char* data, char* obj, no) { return 0; }
@@ -41,6 +242,9 @@ private:
 	template <typename U>
 	static size_t size(const char* data, const char* obj, no) { return 0; }
 
+	template <typename U>
+	static size_t extent(const char* data, size_t avail, no) { return 0; }
+
 	template <typename U>
 	static size_t read(const char* data, char* obj, yes)
 	{
@@ -79,9 +283,249 @@ private:
 		typedef typename std::conditional<(std::tuple_size<tail>::value > 0), yes, no>::type bool_type;
 		return sz + size<tail>(data, obj, bool_type());
 	}
+
+	template <typename U>
+	static size_t extent(const char* data, size_t avail, yes)
+	{
+		typedef typename std::tuple_element<0, U>::type HeadType;
+		size_t sz = worker_extent<HeadType, E>(data, avail);
+		if (extent_failed(sz))
+			return sz;
+		typedef typename remove_tuple_head<U>::type tail;
+		typedef typename std::conditional<(std::tuple_size<tail>::value > 0), yes, no>::type bool_type;
+		size_t rest = extent<tail>(data + sz, avail - sz, bool_type());
+		return extent_failed(rest) ? rest : sz + rest;
+	}
 };
 // End for serializable struct type
 
+// Access to a single field of a struct through its field mark
+template <typename M, bool E, typename TagT = void>
+struct field_io
+{
+	typedef typename M::type type;
+	template <typename S>
+	static size_t read(const char* data, S& s) { return rw_worker<type, E, type>::read(data, M::ref(s)); }
+	template <typename S>
+	static size_t write(char* data, const S& s) { return rw_worker<type, E, type>::write(data, M::ref(s)); }
+	template <typename S>
+	static size_t size(const char* data, const S& s) { return rw_worker<type, E, type>::size(data, M::ref(s)); }
+	static size_t extent(const char* data, size_t avail) { return worker_extent<type, E>(data, avail); }
+};
+
+// A bit field on its own takes the fewest whole bytes, lowest byte first
+template <typename M, bool E>
+struct field_io<M, E, typename std::enable_if<is_bit_field<typename M::type>::value>::type>
+{
+	typedef typename M::type type;
+	static const size_t bytes = (type::bits + 7) / 8;
+	template <typename S>
+	static size_t read(const char* data, S& s)
+	{
+		uint64_t v = 0;
+		for (size_t i = 0; i < bytes; i++)
+			v |= (uint64_t)(uint8_t)data[i] << (8 * i);
+		M::set(s, type::from_bits(v));
+		return bytes;
+	}
+	template <typename S>
+	static size_t write(char* data, const S& s)
+	{
+		uint64_t v = type::to_bits(M::get(s));
+		for (size_t i = 0; i < bytes; i++)
+			data[i] = (char)(v >> (8 * i));
+		return bytes;
+	}
+	template <typename S>
+	static size_t size(const char* data, const S& s) { return bytes; }
+	static size_t extent(const char* data, size_t avail) { return bytes <= avail ? bytes : bad_extent; }
+};
+// End field access
+
+// Cursor for runs of consecutive bit fields, packed lowest bit first into whole bytes
+template <typename P>
+struct bit_cursor
+{
+	bit_cursor(P p) : pos(p), bit(0) {}
+
+	void put(uint64_t v, size_t n)
+	{
+		for (; n > 0; )
+		{
+			size_t take = std::min<size_t>(8 - bit, n);
+			if (bit == 0) *pos++ = 0;
+			pos[-1] |= (char)((v & ((1u << take) - 1)) << bit);
+			v >>= take;
+			n -= take;
+			bit = (bit + take) % 8;
+		}
+	}
+
+	uint64_t get(size_t n)
+	{
+		uint64_t v = 0;
+		for (size_t done = 0; done < n; )
+		{
+			size_t take = std::min<size_t>(8 - bit, n - done);
+			if (bit == 0) pos++;
+			v |= (uint64_t)(((uint8_t)pos[-1] >> bit) & ((1u << take) - 1)) << done;
+			done += take;
+			bit = (bit + take) % 8;
+		}
+		return v;
+	}
+
+	void skip(size_t n)
+	{
+		pos += (bit + n + 7) / 8 - (bit + 7) / 8;
+		bit = (bit + n) % 8;
+	}
+
+	// Byte aligned fields start after the last partially used byte
+	void close() { bit = 0; }
+
+	P pos;
+	size_t bit;
+};
+// End bit cursor
+
+// For serializable struct declared with PACKED_FIELD_START. Members are reached through
+// their field marks rather than by offset, and consecutive BITFIELDs share bytes.
+template <typename T, bool E>
+struct rw_worker<T, E, typename std::enable_if<is_packed_struct<T>::value, T>::type>
+{
+public:
+	typedef typename T::mark_list marks;
+	static size_t read(const char* data, T& t)
+	{
+		bit_cursor<const char*> c(data);
+		read<marks>(c, t, has_marks<marks>());
+		return c.pos - data;
+	}
+
+	static size_t write(char* data, const T& t)
+	{
+		bit_cursor<char*> c(data);
+		write<marks>(c, t, has_marks<marks>());
+		return c.pos - data;
+	}
+
+	static size_t size(const char* data, const T& t)
+	{
+		bit_cursor<const char*> c(data);
+		size<marks>(c, t, has_marks<marks>());
+		return c.pos - data;
+	}
+
+	static size_t extent(const char* data, size_t avail)
+	{
+		bit_cursor<const char*> c(data);
+		size_t failed = extent<marks>(c, data + avail, has_marks<marks>());
+		return failed ? failed : c.pos - data;
+	}
+
+private:
+	template <typename U>
+	struct has_marks : std::conditional<(std::tuple_size<U>::value > 0), yes, no>::type {};
+
+	template <typename M>
+	struct is_bit_mark : is_bit_field<typename M::type> {};
+
+	template <typename U>
+	static void read(bit_cursor<const char*>& c, T& t, no) {}
+
+	template <typename U>
+	static void write(bit_cursor<char*>& c, const T& t, no) {}
+
+	template <typename U>
+	static void size(bit_cursor<const char*>& c, const T& t, no) {}
+
+	// These return 0 while the fields fit, the failed extent otherwise
+	template <typename U>
+	static size_t extent(bit_cursor<const char*>& c, const char* end, no) { return 0; }
+
+	template <typename U>
+	static size_t extent(bit_cursor<const char*>& c, const char* end, yes)
+	{
+		typedef typename std::tuple_element<0, U>::type HeadMark;
+		size_t failed = extent_field<HeadMark>(c, end, is_bit_mark<HeadMark>());
+		if (failed)
+			return failed;
+		typedef typename remove_tuple_head<U>::type tail;
+		return extent<tail>(c, end, has_marks<tail>());
+	}
+
+	template <typename M>
+	static size_t extent_field(bit_cursor<const char*>& c, const char* end, yes)
+	{
+		c.skip(M::type::bits);
+		return c.pos <= end ? 0 : bad_extent;
+	}
+
+	template <typename M>
+	static size_t extent_field(bit_cursor<const char*>& c, const char* end, no)
+	{
+		c.close();
+		size_t sz = field_io<M, E>::extent(c.pos, end - c.pos);
+		if (extent_failed(sz))
+			return sz;
+		c.pos += sz;
+		return 0;
+	}
+
+	template <typename U>
+	static void read(bit_cursor<const char*>& c, T& t, yes)
+	{
+		typedef typename std::tuple_element<0, U>::type HeadMark;
+		read_field<HeadMark>(c, t, is_bit_mark<HeadMark>());
+		typedef typename remove_tuple_head<U>::type tail;
+		read<tail>(c, t, has_marks<tail>());
+	}
+
+	template <typename U>
+	static void write(bit_cursor<char*>& c, const T& t, yes)
+	{
+		typedef typename std::tuple_element<0, U>::type HeadMark;
+		write_field<HeadMark>(c, t, is_bit_mark<HeadMark>());
+		typedef typename remove_tuple_head<U>::type tail;
+		write<tail>(c, t, has_marks<tail>());
+	}
+
+	template <typename U>
+	static void size(bit_cursor<const char*>& c, const T& t, yes)
+	{
+		typedef typename std::tuple_element<0, U>::type HeadMark;
+		size_field<HeadMark>(c, t, is_bit_mark<HeadMark>());
+		typedef typename remove_tuple_head<U>::type tail;
+		size<tail>(c, t, has_marks<tail>());
+	}
+
+	template <typename M>
+	static void read_field(bit_cursor<const char*>& c, T& t, yes)
+	{ M::set(t, M::type::from_bits(c.get(M::type::bits))); }
+
+	template <typename M>
+	static void read_field(bit_cursor<const char*>& c, T& t, no)
+	{ c.close(); c.pos += field_io<M, E>::read(c.pos, t); }
+
+	template <typename M>
+	static void write_field(bit_cursor<char*>& c, const T& t, yes)
+	{ c.put(M::type::to_bits(M::get(t)), M::type::bits); }
+
+	template <typename M>
+	static void write_field(bit_cursor<char*>& c, const T& t, no)
+	{ c.close(); c.pos += field_io<M, E>::write(c.pos, t); }
+
+	template <typename M>
+	static void size_field(bit_cursor<const char*>& c, const T& t, yes)
+	{ c.skip(M::type::bits); }
+
+	template <typename M>
+	static void size_field(bit_cursor<const char*>& c, const T& t, no)
+	{ c.close(); c.pos += field_io<M, E>::size(c.pos, t); }
+};
+// End for packed serializable struct type
+
 // For arithmetic types
 template <typename T, bool E>
 struct rw_worker<T, E, typename std::enable_if<std::is_arithmetic<T>::value, T>::type>
@@ -101,6 +545,9 @@ public:
 
 	static size_t size(const char* data, const T& t)
 	{ return sizeof(T); }
+
+	static size_t extent(const char* data, size_t avail)
+	{ return sizeof(T) <= avail ? sizeof(T) : bad_extent; }
 private:
 	typedef typename matched_uint<sizeof(T)>::type int_type;
 	// read in network byte order
@@ -145,12 +592,15 @@ struct rw_worker<std::string, E, std::string>
 
 	static size_t size(const char* data, const std::string& t)
 	{ return t.size() + sizeof(uint32_t); }
+
+	static size_t extent(const char* data, size_t avail)
+	{ return counted_extent<char, E>(data, avail); }
 }; 
 // End std::string
 
-// For iterable and modifiable containers, such as vector, map, set, list, etc
+// For iterable and modifiable containers, such as map, set, list, etc
 template <typename T, bool E>
-struct rw_worker<T, E, typename std::enable_if<is_modifiable_container<T>::value, T>::type>
+struct rw_worker<T, E, typename std::enable_if<is_modifiable_container<T>::value && !has_dedicated_rw<T>::value, T>::type>
 {
 	static size_t read(const char* data, T& t)
 	{
@@ -183,9 +633,421 @@ struct rw_worker<T, E, typename std::enable_if<is_modifiable_container<T>::value
 			data += rw_worker<typename T::value_type, E, typename T::value_type>::size(data, i);
 		return data - old;
 	}
+
+	static size_t extent(const char* data, size_t avail)
+	{ return counted_extent<typename T::value_type, E>(data, avail); }
 };
 // End stl containers
 
+// For std::map, std::set and their multi versions. They are written in key order, so each
+// element is decoded into plain locals and emplaced with an end hint, which takes constant
+// time for sorted input and moves the key instead of copying it out of a pair<const K, V>.
+// Unsorted input still decodes correctly, the hint is only a hint.
+template <typename T, bool E>
+struct rw_worker<T, E, typename std::enable_if<is_ordered_associative<T>::value, T>::type>
+{
+	typedef typename T::key_type key_type;
+	typedef typename T::value_type value_type;
+	typedef typename std::is_same<key_type, value_type>::type is_set;
+
+	static size_t read(const char* data, T& t)
+	{
+		uint32_t size = 0;
+		const char* old = data;
+		data += rw_worker<uint32_t, E, uint32_t>::read(data, size);
+		for (uint32_t i = 0; i < size; i++)
+			data += read_elem(data, t, is_set());
+		return data - old;
+	}
+
+	static size_t write(char* data, const T& t)
+	{
+		const char* old = data;
+		data += rw_worker<uint32_t, E, uint32_t>::write(data, t.size());
+		for (auto& i : t)
+			data += rw_worker<value_type, E, value_type>::write(data, i);
+		return data - old;
+	}
+
+	static size_t size(const char* data, const T& t)
+	{
+		const char* old = data;
+		data += sizeof(uint32_t);
+		for (auto& i : t)
+			data += rw_worker<value_type, E, value_type>::size(data, i);
+		return data - old;
+	}
+
+	static size_t extent(const char* data, size_t avail)
+	{ return counted_extent<value_type, E>(data, avail); }
+
+private:
+	static size_t read_elem(const char* data, T& t, yes)
+	{
+		key_type key;
+		size_t sz = rw_worker<key_type, E, key_type>::read(data, key);
+		t.emplace_hint(t.end(), std::move(key));
+		return sz;
+	}
+
+	static size_t read_elem(const char* data, T& t, no)
+	{
+		typedef typename T::mapped_type mapped_type;
+		key_type key;
+		mapped_type value;
+		size_t sz = rw_worker<key_type, E, key_type>::read(data, key);
+		sz += rw_worker<mapped_type, E, mapped_type>::read(data + sz, value);
+		t.emplace_hint(t.end(), std::move(key), std::move(value));
+		return sz;
+	}
+};
+// End ordered associative containers
+
+// For std::vector and std::deque, resized once and read in place. Arithmetic elements
+// that need no byte swapping are copied as one block out of a vector.
+template <typename T, bool E>
+struct rw_worker<T, E, typename std::enable_if<is_resizable_sequence<T>::value, T>::type>
+{
+	typedef typename T::value_type elem_type;
+	typedef typename std::conditional<(std::is_arithmetic<elem_type>::value && !use_network_byteorder<elem_type, E>::value
+				&& std::is_same<T, std::vector<elem_type, typename T::allocator_type>>::value), yes, no>::type block_type;
+
+	static size_t read(const char* data, T& t)
+	{
+		uint32_t size = 0;
+		const char* old = data;
+		data += rw_worker<uint32_t, E, uint32_t>::read(data, size);
+		size_t base = t.size();
+		t.resize(base + size);
+		data += read_elems(data, t, base, block_type());
+		return data - old;
+	}
+
+	static size_t write(char* data, const T& t)
+	{
+		const char* old = data;
+		data += rw_worker<uint32_t, E, uint32_t>::write(data, t.size());
+		data += write_elems(data, t, block_type());
+		return data - old;
+	}
+
+	static size_t size(const char* data, const T& t)
+	{ return sizeof(uint32_t) + size_elems(data + sizeof(uint32_t), t, typename std::is_arithmetic<elem_type>::type()); }
+
+	static size_t extent(const char* data, size_t avail)
+	{ return counted_extent<elem_type, E>(data, avail); }
+
+private:
+	static size_t read_elems(const char* data, T& t, size_t base, yes)
+	{
+		size_t sz = (t.size() - base) * sizeof(elem_type);
+		std::memcpy(t.data() + base, data, sz);
+		return sz;
+	}
+
+	static size_t read_elems(const char* data, T& t, size_t base, no)
+	{
+		const char* old = data;
+		for (size_t i = base; i < t.size(); i++)
+			data += rw_worker<elem_type, E, elem_type>::read(data, t[i]);
+		return data - old;
+	}
+
+	static size_t write_elems(char* data, const T& t, yes)
+	{
+		std::memcpy(data, t.data(), t.size() * sizeof(elem_type));
+		return t.size() * sizeof(elem_type);
+	}
+
+	static size_t write_elems(char* data, const T& t, no)
+	{
+		char* old = data;
+		for (auto& i : t)
+			data += rw_worker<elem_type, E, elem_type>::write(data, i);
+		return data - old;
+	}
+
+	static size_t size_elems(const char* data, const T& t, yes)
+	{ return t.size() * sizeof(elem_type); }
+
+	static size_t size_elems(const char* data, const T& t, no)
+	{
+		const char* old = data;
+		for (auto& i : t)
+			data += rw_worker<elem_type, E, elem_type>::size(data, i);
+		return data - old;
+	}
+};
+// End std::vector and std::deque
+
+// Specialization for std::vector<bool>, bit-packed with the lowest bit first
+template <typename A, bool E>
+struct rw_worker<std::vector<bool, A>, E, std::vector<bool, A>>
+{
+	static size_t read(const char* data, std::vector<bool, A>& t)
+	{
+		uint32_t size = 0;
+		data += rw_worker<uint32_t, E, uint32_t>::read(data, size);
+		t.reserve(t.size() + size);
+		for (uint32_t i = 0; i < size; i++)
+			t.push_back(((uint8_t)data[i / 8] >> (i % 8)) & 1);
+		return sizeof(uint32_t) + (size + 7) / 8;
+	}
+
+	static size_t write(char* data, const std::vector<bool, A>& t)
+	{
+		data += rw_worker<uint32_t, E, uint32_t>::write(data, t.size());
+		std::memset(data, 0, (t.size() + 7) / 8);
+		for (size_t i = 0; i < t.size(); i++)
+			if (t[i]) data[i / 8] |= (char)(1 << (i % 8));
+		return sizeof(uint32_t) + (t.size() + 7) / 8;
+	}
+
+	static size_t size(const char* data, const std::vector<bool, A>& t)
+	{ return sizeof(uint32_t) + (t.size() + 7) / 8; }
+
+	static size_t extent(const char* data, size_t avail)
+	{
+		uint32_t size = 0;
+		if (avail < sizeof(uint32_t))
+			return bad_extent;
+		rw_worker<uint32_t, E, uint32_t>::read(data, size);
+		size_t sz = sizeof(uint32_t) + ((size_t)size + 7) / 8;
+		return sz <= avail ? sz : bad_extent;
+	}
+};
+// End std::vector<bool>
+
+// Specialization for std::forward_list, which has neither size() nor insert()
+template <typename T, typename A, bool E>
+struct rw_worker<std::forward_list<T, A>, E, std::forward_list<T, A>>
+{
+	static size_t read(const char* data, std::forward_list<T, A>& t)
+	{
+		uint32_t size = 0;
+		const char* old = data;
+		data += rw_worker<uint32_t, E, uint32_t>::read(data, size);
+		auto last = t.before_begin();
+		for (auto it = t.begin(); it != t.end(); ++it, ++last);
+		for (uint32_t i = 0; i < size; i++)
+		{
+			last = t.emplace_after(last);
+			data += rw_worker<T, E, T>::read(data, *last);
+		}
+		return data - old;
+	}
+
+	static size_t write(char* data, const std::forward_list<T, A>& t)
+	{
+		char* old = data;
+		char* count = data;
+		uint32_t size = 0;
+		data += sizeof(uint32_t);
+		for (auto& i : t)
+		{
+			data += rw_worker<T, E, T>::write(data, i);
+			size++;
+		}
+		rw_worker<uint32_t, E, uint32_t>::write(count, size);
+		return data - old;
+	}
+
+	static size_t size(const char* data, const std::forward_list<T, A>& t)
+	{
+		const char* old = data;
+		data += sizeof(uint32_t);
+		for (auto& i : t)
+			data += rw_worker<T, E, T>::size(data, i);
+		return data - old;
+	}
+
+	static size_t extent(const char* data, size_t avail)
+	{ return counted_extent<T, E>(data, avail); }
+};
+// End std::forward_list
+
+// Specialization for std::unique_ptr, a presence byte followed by the pointee
+template <typename T, typename D, bool E>
+struct rw_worker<std::unique_ptr<T, D>, E, std::unique_ptr<T, D>>
+{
+	static size_t read(const char* data, std::unique_ptr<T, D>& t)
+	{
+		if (!*data)
+		{
+			t.reset();
+			return 1;
+		}
+		if (!t) t.reset(new T());
+		return 1 + rw_worker<T, E, T>::read(data + 1, *t);
+	}
+
+	static size_t write(char* data, const std::unique_ptr<T, D>& t)
+	{
+		*data = t ? 1 : 0;
+		return t ? 1 + rw_worker<T, E, T>::write(data + 1, *t) : 1;
+	}
+
+	static size_t size(const char* data, const std::unique_ptr<T, D>& t)
+	{ return t ? 1 + rw_worker<T, E, T>::size(data + 1, *t) : 1; }
+
+	static size_t extent(const char* data, size_t avail)
+	{
+		if (avail < 1)
+			return bad_extent;
+		if (!*data)
+			return 1;
+		size_t sz = worker_extent<T, E>(data + 1, avail - 1);
+		return extent_failed(sz) ? sz : 1 + sz;
+	}
+};
+// End std::unique_ptr
+
+#if __cplusplus >= 201703L
+// Specialization for std::optional, a presence byte followed by the value
+template <typename T, bool E>
+struct rw_worker<std::optional<T>, E, std::optional<T>>
+{
+	static size_t read(const char* data, std::optional<T>& t)
+	{
+		if (!*data)
+		{
+			t.reset();
+			return 1;
+		}
+		if (!t) t.emplace();
+		return 1 + rw_worker<T, E, T>::read(data + 1, *t);
+	}
+
+	static size_t write(char* data, const std::optional<T>& t)
+	{
+		*data = t ? 1 : 0;
+		return t ? 1 + rw_worker<T, E, T>::write(data + 1, *t) : 1;
+	}
+
+	static size_t size(const char* data, const std::optional<T>& t)
+	{ return t ? 1 + rw_worker<T, E, T>::size(data + 1, *t) : 1; }
+
+	static size_t extent(const char* data, size_t avail)
+	{
+		if (avail < 1)
+			return bad_extent;
+		if (!*data)
+			return 1;
+		size_t sz = worker_extent<T, E>(data + 1, avail - 1);
+		return extent_failed(sz) ? sz : 1 + sz;
+	}
+};
+// End std::optional
+
+// Specialization for std::variant, the active index followed by the active alternative only
+template <typename ...Ts, bool E>
+struct rw_worker<std::variant<Ts...>, E, std::variant<Ts...>>
+{
+	typedef std::variant<Ts...> variant_type;
+	static_assert(sizeof...(Ts) < 0xff, "too many alternatives");
+	static const uint8_t valueless = 0xff;
+
+	static size_t read(const char* data, variant_type& t)
+	{
+		uint8_t index = (uint8_t)*data;
+		return 1 + read_alt<0>(data + 1, t, index);
+	}
+
+	static size_t write(char* data, const variant_type& t)
+	{
+		if (t.valueless_by_exception())
+		{
+			*data = (char)valueless;
+			return 1;
+		}
+		*data = (char)t.index();
+		return 1 + std::visit([data](const auto& v) {
+			typedef std::decay_t<decltype(v)> alt_type;
+			return rw_worker<alt_type, E, alt_type>::write(data + 1, v);
+		}, t);
+	}
+
+	static size_t size(const char* data, const variant_type& t)
+	{
+		if (t.valueless_by_exception())
+			return 1;
+		return 1 + std::visit([data](const auto& v) {
+			typedef std::decay_t<decltype(v)> alt_type;
+			return rw_worker<alt_type, E, alt_type>::size(data + 1, v);
+		}, t);
+	}
+
+	static size_t extent(const char* data, size_t avail)
+	{
+		if (avail < 1)
+			return bad_extent;
+		if ((uint8_t)*data == valueless)
+			return 1;
+		size_t sz = extent_alt<0>(data + 1, avail - 1, (uint8_t)*data);
+		return extent_failed(sz) ? sz : 1 + sz;
+	}
+
+private:
+	template <size_t N>
+	static size_t read_alt(const char* data, variant_type& t, uint8_t index)
+	{
+		if constexpr (N < sizeof...(Ts))
+		{
+			if (index != N)
+				return read_alt<N + 1>(data, t, index);
+			typedef std::variant_alternative_t<N, variant_type> alt_type;
+			if (t.index() != N) t.template emplace<N>();
+			return rw_worker<alt_type, E, alt_type>::read(data, std::get<N>(t));
+		}
+		else
+			return 0;
+	}
+
+	template <size_t N>
+	static size_t extent_alt(const char* data, size_t avail, uint8_t index)
+	{
+		if constexpr (N < sizeof...(Ts))
+		{
+			if (index != N)
+				return extent_alt<N + 1>(data, avail, index);
+			typedef std::variant_alternative_t<N, variant_type> alt_type;
+			return worker_extent<alt_type, E>(data, avail);
+		}
+		else
+			return bad_extent;
+	}
+};
+// End std::variant
+
+// Specialization for std::string_view, same wire format as std::string. A decoded view
+// points into the source buffer and is only valid as long as that buffer is.
+template <bool E>
+struct rw_worker<std::string_view, E, std::string_view>
+{
+	static size_t read(const char* data, std::string_view& t)
+	{
+		uint32_t str_len = 0;
+		rw_worker<uint32_t, E, uint32_t>::read(data, str_len);
+		t = std::string_view(data + sizeof(uint32_t), str_len);
+		return sizeof(uint32_t) + str_len;
+	}
+
+	static size_t write(char* data, const std::string_view& t)
+	{
+		rw_worker<uint32_t, E, uint32_t>::write(data, (uint32_t)t.size());
+		std::memcpy(data + sizeof(uint32_t), t.data(), t.size());
+		return sizeof(uint32_t) + t.size();
+	}
+
+	static size_t size(const char* data, const std::string_view& t)
+	{ return t.size() + sizeof(uint32_t); }
+
+	static size_t extent(const char* data, size_t avail)
+	{ return counted_extent<char, E>(data, avail); }
+};
+// End std::string_view
+#endif
+
 // For raw arrays
 template <typename T, bool E>
 struct rw_worker<T, E, typename std::enable_if<std::is_array<T>::value, T>::type>
@@ -214,6 +1076,11 @@ struct rw_worker<T, E, typename std::enable_if<std::is_array<T>::value, T>::type
 			sz += rw_worker<subtype, E, subtype>::size(data, t[i]);
 		return sz;
 	}
+	static size_t extent(const char* data, size_t avail)
+	{
+		typedef typename std::remove_cv<typename std::remove_extent<T>::type>::type subtype;
+		return elems_extent<subtype, E>(data, avail, std::extent<T, 0>::value);
+	}
 };
 // End raw arrays
 
@@ -245,6 +1112,9 @@ struct rw_worker<std::array<T, N>, E, std::array<T, N>>
 			sz += rw_worker<elem_type, E, elem_type>::size(data, t[i]);
 		return sz;
 	}
+
+	static size_t extent(const char* data, size_t avail)
+	{ return elems_extent<elem_type, E>(data, avail, N); }
 };
 // End std::array
 
@@ -279,6 +1149,16 @@ struct rw_worker<std::pair<U, V>, E, std::pair<U, V>>
 		data += rw_worker<second_type, E, second_type>::size(data, t.second);
 		return data - old;
 	}
+	static size_t extent(const char* data, size_t avail)
+	{
+		typedef typename std::remove_cv<U>::type first_type; 
+		typedef typename std::remove_cv<V>::type second_type; 
+		size_t first = worker_extent<first_type, E>(data, avail);
+		if (extent_failed(first))
+			return first;
+		size_t second = worker_extent<second_type, E>(data + first, avail - first);
+		return extent_failed(second) ? second : first + second;
+	}
 };
 // End std::pair
 
@@ -303,6 +1183,11 @@ public:
 		typedef typename std::conditional<(std::tuple_size<T>::value > 0), yes, no>::type bool_type;
 		return size<T, 0>(data, t, bool_type());
 	}
+	static size_t extent(const char* data, size_t avail)
+	{
+		typedef typename std::conditional<(std::tuple_size<T>::value > 0), yes, no>::type bool_type;
+		return extent<T, 0>(data, avail, bool_type());
+	}
 private:
 	template <typename TP, size_t N>
 	static size_t read(const char* data, TP& t, no) { return 0; }
@@ -342,6 +1227,20 @@ private:
 		typedef typename std::conditional<(std::tuple_size<TP>::value > N+1), yes, no>::type bool_type;
 		return data - old + size<TP, N+1>(data, t, bool_type());
 	}
+
+	template <typename TP, size_t N>
+	static size_t extent(const char* data, size_t avail, no) { return 0; }
+	template<typename TP, size_t N>
+	static size_t extent(const char* data, size_t avail, yes)
+	{
+		typedef typename std::tuple_element<N, TP>::type elem_type;
+		size_t sz = worker_extent<elem_type, E>(data, avail);
+		if (extent_failed(sz))
+			return sz;
+		typedef typename std::conditional<(std::tuple_size<TP>::value > N+1), yes, no>::type bool_type;
+		size_t rest = extent<TP, N+1>(data + sz, avail - sz, bool_type());
+		return extent_failed(rest) ? rest : sz + rest;
+	}
 };
 // End std::tuple
 
@@ -351,6 +1250,7 @@ struct rw
 	static size_t read(const char* data, T& t) { return rw_worker<T, E, T>::read(data, t); }
 	static size_t write(char* data, const T& t) { return rw_worker<T, E, T>::write(data, t); }
 	static size_t size(const char* data, const T& t) { return rw_worker<T, E, T>::size(data, t); }
+	static size_t extent(const char* data, size_t avail) { return worker_extent<T, E>(data, avail); }
 };
 
 }
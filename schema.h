@@ -0,0 +1,405 @@
+#ifndef SIMPLE_BUFFER_SCHEMA_DEF
+#define SIMPLE_BUFFER_SCHEMA_DEF
+#include <cstdint>
+#include <string>
+#include <tuple>
+#include <array>
+#include "read_write.h"
+
+namespace simple_buffer
+{
+
+// Compile-time fingerprint of the wire format of a type. Types that are encoded
+// identically (vector/list, std::array/raw array, pair/2-tuple) share a fingerprint.
+// Struct fingerprints also cover the field names.
+constexpr uint64_t schema_mix(uint64_t seed, uint64_t v)
+{
+	return (seed ^ (v + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2))) * 0x100000001b3ULL;
+}
+
+constexpr uint64_t schema_name_hash(const char* name, uint64_t seed = 0xcbf29ce484222325ULL)
+{
+	return *name ? schema_name_hash(name + 1, schema_mix(seed, (uint8_t)*name)) : seed;
+}
+
+enum schema_kind : uint64_t
+{
+	schema_arith = 1,
+	schema_string,
+	schema_sequence,
+	schema_fixed,
+	schema_tuple,
+	schema_struct,
+	schema_bits,
+	schema_optional,
+	schema_variant,
+	schema_bit_field
+};
+
+template <typename T, typename TagT = void>
+struct schema_hash{};
+
+template <typename T>
+struct schema_hash<T, typename std::enable_if<std::is_arithmetic<T>::value, T>::type>
+{
+	static constexpr uint64_t value = schema_mix(schema_mix(schema_mix(schema_arith, sizeof(T)),
+										std::is_floating_point<T>::value), std::is_signed<T>::value);
+};
+
+template <>
+struct schema_hash<std::string, std::string>
+{
+	static constexpr uint64_t value = schema_mix(schema_string, 0);
+};
+
+// Containers with their own encoding, kept out of the generic sequence fingerprint
+template <typename T>
+struct has_dedicated_schema : no {};
+
+template <typename A>
+struct has_dedicated_schema<std::vector<bool, A>> : yes {};
+
+template <typename T>
+struct schema_hash<T, typename std::enable_if<is_modifiable_container<T>::value && !has_dedicated_schema<T>::value, T>::type>
+{
+	typedef typename std::remove_cv<typename T::value_type>::type elem_type;
+	static constexpr uint64_t value = schema_mix(schema_sequence, schema_hash<elem_type, elem_type>::value);
+};
+
+template <typename T>
+struct schema_hash<T, typename std::enable_if<std::is_array<T>::value, T>::type>
+{
+	typedef typename std::remove_cv<typename std::remove_extent<T>::type>::type elem_type;
+	static constexpr uint64_t value = schema_mix(schema_mix(schema_fixed, std::extent<T, 0>::value),
+										schema_hash<elem_type, elem_type>::value);
+};
+
+template <typename T, size_t N>
+struct schema_hash<std::array<T, N>, std::array<T, N>>
+{
+	static constexpr uint64_t value = schema_hash<T[N], T[N]>::value;
+};
+
+// Fold over the element types of a tuple
+template <typename T>
+struct schema_fold { static constexpr uint64_t value = schema_tuple; };
+
+template <typename T, typename ...Ts>
+struct schema_fold<std::tuple<T, Ts...>>
+{
+	typedef typename std::remove_cv<T>::type head_type;
+	static constexpr uint64_t value = schema_mix(schema_fold<std::tuple<Ts...>>::value, schema_hash<head_type, head_type>::value);
+};
+
+template <typename U, typename V>
+struct schema_hash<std::pair<U, V>, std::pair<U, V>>
+{
+	static constexpr uint64_t value = schema_fold<std::tuple<U, V>>::value;
+};
+
+template <typename T>
+struct schema_hash<T, typename std::enable_if<!std::is_void<typename remove_tuple_head<T>::type>::value, T>::type>
+{
+	static constexpr uint64_t value = schema_fold<T>::value;
+};
+
+// A struct field, name and type
+template <typename M>
+struct schema_mark_hash
+{
+	typedef typename M::type type;
+	static constexpr uint64_t value = schema_mix(schema_name_hash(M::field_name()), schema_hash<type, type>::value);
+};
+
+// Fold over the field marks of a struct
+template <typename T>
+struct schema_mark_fold { static constexpr uint64_t value = schema_struct; };
+
+template <typename M, typename ...Ms>
+struct schema_mark_fold<std::tuple<M, Ms...>>
+{
+	static constexpr uint64_t value = schema_mix(schema_mark_fold<std::tuple<Ms...>>::value, schema_mark_hash<M>::value);
+};
+
+template <typename T>
+struct schema_hash<T, typename std::enable_if<is_serializable_struct<T>::value, T>::type>
+{
+	static constexpr uint64_t value = schema_mark_fold<typename T::mark_list>::value;
+};
+
+template <typename T, size_t N>
+struct schema_hash<bit_field<T, N>, bit_field<T, N>>
+{
+	static constexpr uint64_t value = schema_mix(schema_mix(schema_bit_field, N), std::is_signed<typename bit_field<T, N>::int_type>::value);
+};
+
+template <typename A>
+struct schema_hash<std::vector<bool, A>, std::vector<bool, A>>
+{
+	static constexpr uint64_t value = schema_mix(schema_bits, 0);
+};
+
+template <typename T, typename D>
+struct schema_hash<std::unique_ptr<T, D>, std::unique_ptr<T, D>>
+{
+	static constexpr uint64_t value = schema_mix(schema_optional, schema_hash<T, T>::value);
+};
+
+#if __cplusplus >= 201703L
+template <typename T>
+struct schema_hash<std::optional<T>, std::optional<T>>
+{
+	static constexpr uint64_t value = schema_mix(schema_optional, schema_hash<T, T>::value);
+};
+
+template <typename ...Ts>
+struct schema_hash<std::variant<Ts...>, std::variant<Ts...>>
+{
+	static constexpr uint64_t value = schema_mix(schema_variant, schema_fold<std::tuple<Ts...>>::value);
+};
+
+template <>
+struct schema_hash<std::string_view, std::string_view>
+{
+	static constexpr uint64_t value = schema_hash<std::string, std::string>::value;
+};
+#endif
+
+template <typename T>
+struct schema_fingerprint { static constexpr uint64_t value = schema_hash<T, T>::value; };
+
+// Per field tag used by the tagged path, from the field name and type
+template <typename M>
+struct schema_field_tag
+{
+	static constexpr uint32_t value = (uint32_t)(schema_mark_hash<M>::value ^ (schema_mark_hash<M>::value >> 32));
+};
+// End compile-time fingerprint
+
+
+// Versioned envelope around a serializable struct:
+//   uint64 fingerprint | uint8 mode | uint32 payload length | payload
+// In fast mode the payload is the plain struct encoding. In tagged mode it is
+//   uint32 field count | (uint32 field tag | uint32 field length | field)...
+// A reader whose fingerprint matches takes the fast path. Otherwise a tagged payload
+// is decoded field by field, matching fields by tag and skipping unknown tags by their
+// length; fields the writer doesn't have keep their value. A fast payload with another
+// fingerprint can't be decoded: checked buffers fail the read, unchecked ones skip it.
+// Writers must therefore use tagged mode while schemas are being rolled out.
+enum class schema_path : uint8_t { none, fast, tagged, skipped };
+
+template <typename T>
+struct versioned
+{
+	static_assert(is_serializable_struct<T>::value, "versioned requires a FIELD struct");
+	versioned(T& t, bool tagged_in = false) : obj(t), tagged(tagged_in), path(schema_path::none) {}
+	T& obj;
+	bool tagged;
+	schema_path path;
+};
+
+template <typename T>
+versioned<T> make_versioned(T& t, bool tagged = false) { return versioned<T>(t, tagged); }
+
+template <typename T, bool E>
+struct rw_worker<versioned<T>, E, versioned<T>>
+{
+	typedef typename T::mark_list marks;
+	static const size_t header_size = sizeof(uint64_t) + sizeof(uint8_t) + sizeof(uint32_t);
+	static const size_t field_header_size = 2 * sizeof(uint32_t);
+	enum : uint8_t { mode_fast = 0, mode_tagged = 1 };
+
+	static size_t read(const char* data, versioned<T>& t)
+	{
+		uint64_t fp = 0;
+		uint8_t mode = 0;
+		uint32_t len = 0;
+		data += rw_worker<uint64_t, E, uint64_t>::read(data, fp);
+		data += rw_worker<uint8_t, E, uint8_t>::read(data, mode);
+		data += rw_worker<uint32_t, E, uint32_t>::read(data, len);
+		if (fp == schema_fingerprint<T>::value && mode == mode_fast)
+		{
+			rw_worker<T, E, T>::read(data, t.obj);
+			t.path = schema_path::fast;
+		}
+		else if (mode == mode_tagged)
+		{
+			uint32_t count = 0;
+			data += rw_worker<uint32_t, E, uint32_t>::read(data, count);
+			read_fields(data, t.obj, count);
+			t.path = schema_path::tagged;
+		}
+		else
+			t.path = schema_path::skipped;
+		return header_size + len;
+	}
+
+	static size_t write(char* data, const versioned<T>& t)
+	{
+		char* payload = data + header_size;
+		size_t len = 0;
+		if (t.tagged)
+		{
+			const uint32_t count = std::tuple_size<marks>::value;
+			len += rw_worker<uint32_t, E, uint32_t>::write(payload, count);
+			len += write_fields<marks>(payload + len, t.obj, has_fields<marks>());
+		}
+		else
+			len = rw_worker<T, E, T>::write(payload, t.obj);
+		data += rw_worker<uint64_t, E, uint64_t>::write(data, (uint64_t)schema_fingerprint<T>::value);
+		data += rw_worker<uint8_t, E, uint8_t>::write(data, t.tagged ? mode_tagged : mode_fast);
+		rw_worker<uint32_t, E, uint32_t>::write(data, (uint32_t)len);
+		return header_size + len;
+	}
+
+	static size_t extent(const char* data, size_t avail)
+	{
+		uint64_t fp = 0;
+		uint8_t mode = 0;
+		uint32_t len = 0;
+		if (avail < header_size)
+			return bad_extent;
+		data += rw_worker<uint64_t, E, uint64_t>::read(data, fp);
+		data += rw_worker<uint8_t, E, uint8_t>::read(data, mode);
+		data += rw_worker<uint32_t, E, uint32_t>::read(data, len);
+		if (len > avail - header_size)
+			return bad_extent;
+		if (mode == mode_tagged)
+		{
+			uint32_t count = 0;
+			if (len < sizeof(uint32_t))
+				return bad_extent;
+			data += rw_worker<uint32_t, E, uint32_t>::read(data, count);
+			size_t failed = extent_fields(data, data + len - sizeof(uint32_t), count);
+			if (failed)
+				return failed;
+		}
+		else if (fp != schema_fingerprint<T>::value || mode != mode_fast)
+			return bad_extent;
+		else
+		{
+			size_t sz = worker_extent<T, E>(data, len);
+			if (extent_failed(sz))
+				return sz;
+		}
+		return header_size + len;
+	}
+
+	static size_t size(const char* data, const versioned<T>& t)
+	{
+		if (t.tagged)
+			return header_size + sizeof(uint32_t) + size_fields<marks>(data, t.obj, has_fields<marks>());
+		return header_size + rw_worker<T, E, T>::size(data, t.obj);
+	}
+
+private:
+	template <typename U>
+	struct has_fields : std::conditional<(std::tuple_size<U>::value > 0), yes, no>::type {};
+
+	static void read_fields(const char* data, T& obj, uint32_t count)
+	{
+		for (; count > 0; count--)
+		{
+			uint32_t tag = 0, len = field_length(data);
+			rw_worker<uint32_t, E, uint32_t>::read(data, tag);
+			data += field_header_size;
+			read_field<marks>(data, obj, tag, has_fields<marks>());
+			data += len;
+		}
+	}
+
+	// Unknown tags are fields we don't have
+	template <typename U>
+	static void read_field(const char* data, T& obj, uint32_t tag, no) {}
+
+	template <typename U>
+	static void read_field(const char* data, T& obj, uint32_t tag, yes)
+	{
+		typedef typename std::tuple_element<0, U>::type HeadMark;
+		if (tag == schema_field_tag<HeadMark>::value)
+		{
+			field_io<HeadMark, E>::read(data, obj);
+			return;
+		}
+		typedef typename remove_tuple_head<U>::type tail;
+		read_field<tail>(data, obj, tag, has_fields<tail>());
+	}
+
+	// 0 while the fields fit, the failed extent otherwise
+	static size_t extent_fields(const char* data, const char* end, uint32_t count)
+	{
+		for (; count > 0; count--)
+		{
+			if ((size_t)(end - data) < field_header_size)
+				return bad_extent;
+			uint32_t tag = 0, len = field_length(data);
+			rw_worker<uint32_t, E, uint32_t>::read(data, tag);
+			data += field_header_size;
+			if (len > (size_t)(end - data))
+				return bad_extent;
+			size_t sz = field_extent<marks>(data, len, tag, has_fields<marks>());
+			if (extent_failed(sz))
+				return sz;
+			data += len;
+		}
+		return 0;
+	}
+
+	template <typename U>
+	static size_t field_extent(const char* data, size_t len, uint32_t tag, no) { return 0; }
+
+	template <typename U>
+	static size_t field_extent(const char* data, size_t len, uint32_t tag, yes)
+	{
+		typedef typename std::tuple_element<0, U>::type HeadMark;
+		if (tag == schema_field_tag<HeadMark>::value)
+			return field_io<HeadMark, E>::extent(data, len);
+		typedef typename remove_tuple_head<U>::type tail;
+		return field_extent<tail>(data, len, tag, has_fields<tail>());
+	}
+
+	template <typename U>
+	static size_t write_fields(char* data, const T& obj, no) { return 0; }
+
+	template <typename U>
+	static size_t write_fields(char* data, const T& obj, yes)
+	{
+		typedef typename std::tuple_element<0, U>::type HeadMark;
+		size_t sz = field_io<HeadMark, E>::write(data + field_header_size, obj);
+		rw_worker<uint32_t, E, uint32_t>::write(data, (uint32_t)schema_field_tag<HeadMark>::value);
+		rw_worker<uint32_t, E, uint32_t>::write(data + sizeof(uint32_t), (uint32_t)sz);
+		sz += field_header_size;
+		typedef typename remove_tuple_head<U>::type tail;
+		return sz + write_fields<tail>(data + sz, obj, has_fields<tail>());
+	}
+
+	template <typename U>
+	static size_t size_fields(const char* data, const T& obj, no) { return 0; }
+
+	template <typename U>
+	static size_t size_fields(const char* data, const T& obj, yes)
+	{
+		typedef typename std::tuple_element<0, U>::type HeadMark;
+		size_t sz = field_header_size + field_io<HeadMark, E>::size(data, obj);
+		typedef typename remove_tuple_head<U>::type tail;
+		return sz + size_fields<tail>(data + sz, obj, has_fields<tail>());
+	}
+
+	static uint32_t field_length(const char* data)
+	{
+		uint32_t len = 0;
+		rw_worker<uint32_t, E, uint32_t>::read(data + sizeof(uint32_t), len);
+		return len;
+	}
+};
+
+template <typename T, bool E>
+struct extent_traits<versioned<T>, E, versioned<T>>
+{
+	static const size_t min_size = rw_worker<versioned<T>, E, versioned<T>>::header_size;
+	static const bool known = extent_traits<T, E, T>::known;
+};
+// End versioned envelope
+
+}
+#endif // end of SIMPLE_BUFFER_SCHEMA_DEF
\ No newline at end of file
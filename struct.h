@@ -2,24 +2,43 @@
 #define SIMPLE_BUFFER_BASE_STRUCT_DEF
 #include <tuple>
 #include "read_write.h"
+#include "schema.h"
 #include "buffer.h"
 
 namespace simple_buffer
 {
 
-#define FIELD_START()																													\
+#define FIELD_LAYOUT_START(packed)																										\
 struct sentinel{};																														\
-template <size_t N, bool dummy>	struct field_mark{ typedef void type; };           														\
-template<bool dummy> struct field_mark<__LINE__, dummy>{ typedef sentinel type;};														\
+typedef packed _packed_layout_;																											\
+template <size_t N, bool dummy>	struct field_mark{ typedef void type; };																	\
+template<bool dummy> struct field_mark<__LINE__, dummy>{ typedef sentinel type;};
+
+#define FIELD_START() FIELD_LAYOUT_START(no)
+
+// Natural member alignment, BITFIELD members allowed, bit fields are packed on the wire
+#define PACKED_FIELD_START() FIELD_LAYOUT_START(yes)
 
 
 #define FIELD(name, ...) 																												\
-alignas(sizeof(void*)) __VA_ARGS__ name;                              																	\
-template <bool dummy> struct field_mark<__LINE__, dummy> { typedef __VA_ARGS__ type; };
+alignas(field_alignment<_packed_layout_, __VA_ARGS__>::value) __VA_ARGS__ name;															\
+template <bool dummy> struct field_mark<__LINE__, dummy> { typedef __VA_ARGS__ type;														\
+	static constexpr const char* field_name() { return #name; }																			\
+	template <typename S> static auto ref(S& s) -> decltype((s.name)) { return s.name; } };
+
+#define ARRAY(name, extent, ...)																											\
+alignas(field_alignment<_packed_layout_, __VA_ARGS__>::value) __VA_ARGS__ name extent;													\
+template <bool dummy> struct field_mark<__LINE__, dummy> { typedef decltype(name) type;													\
+	static constexpr const char* field_name() { return #name; }																			\
+	template <typename S> static auto ref(S& s) -> decltype((s.name)) { return s.name; } };
 
-#define ARRAY(name, extent, ...)																										\
-alignas(sizeof(void*)) __VA_ARGS__ name extent;																							\
-template <bool dummy> struct field_mark<__LINE__, dummy> { typedef decltype(name) type; };
+#define BITFIELD(name, width, ...)																									\
+__VA_ARGS__ name : width;																													\
+template <bool dummy> struct field_mark<__LINE__, dummy> { typedef bit_field<__VA_ARGS__, width> type;										\
+	static_assert(_packed_layout_::value, "BITFIELD requires PACKED_FIELD_START");														\
+	static constexpr const char* field_name() { return #name; }																			\
+	template <typename S> static type::value_type get(const S& s) { return s.name; }														\
+	template <typename S> static void set(S& s, type::value_type v) { s.name = v; } };
 
 
 #define FIELD_END()                                                                                                         			\
@@ -28,7 +47,7 @@ struct field_collector{};																												\
 template <bool dummy, size_t N, typename T, typename ...Args>																			\
 struct field_collector<dummy, N, T, std::tuple<Args...>>																				\
 {																																		\
-	typedef typename field_collector<dummy, N-1, typename field_mark<N-1, dummy>::type, std::tuple<T, Args...>>::type type;				\
+	typedef typename field_collector<dummy, N-1, typename field_mark<N-1, dummy>::type, std::tuple<field_mark<N, dummy>, Args...>>::type type;				\
 };																																		\
 template <bool dummy, size_t N, typename ...Args>																						\
 struct field_collector<dummy, N, void, std::tuple<Args...>>																				\
@@ -41,7 +60,8 @@ struct field_collector<dummy, N, sentinel, std::tuple<Args...>>
 	typedef std::tuple<Args...> type;																									\
 };																																		\
 typedef int _trust_me_i_am_your_type_;																									\
-typedef field_collector<true, __LINE__, void, std::tuple<>>::type type_list;															\
+typedef field_collector<true, __LINE__, void, std::tuple<>>::type mark_list;															\
+typedef mark_types<mark_list>::type type_list;																							\
 std::string str() { auto_buf ab; return ab.write(*this).str();  }																		\
 
 }